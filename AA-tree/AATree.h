@@ -1,6 +1,21 @@
 ﻿#include <functional>
 #include <stdexcept>
 #include <algorithm>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include "BloomFilter.h"
+
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#endif
 
 template <typename T>
 class AATree
@@ -9,6 +24,8 @@ public:
 
   class Iterator;
   class Comparator;
+  class Chunk;
+  struct Delta;
 
   AATree();
   AATree(std::initializer_list<T> list);
@@ -20,18 +37,36 @@ public:
   void insert(const T & data);
   void remove(const T & data);
   void clear();
+  static void waitForReclamation();
+
+  void enableFilter(double falsePositiveRate = 0.01, size_t memoryBudget = 0);
+  void disableFilter();
 
   void swap(AATree & firstTree, AATree & secondTree);
 
   bool contains(const T & data);
+  std::vector<bool> containsMany(const std::vector<T> & keys);
+  std::vector<Iterator> findMany(const std::vector<T> & keys);
   bool isEmpty();
   size_t getSize();
 
   Iterator begin();
   Iterator end();
 
+  std::vector<Chunk> partition(size_t chunkCount);
+  template <typename Function>
+  void parallelForEach(Function function, size_t threadCount = 0);
+
+  static Delta diff(AATree & oldTree, AATree & newTree);
+  static std::vector<uint8_t> encodeDelta(const Delta & delta);
+  static Delta decodeDelta(const std::vector<uint8_t> & bytes);
+  void applyDelta(const Delta & delta);
+
 private:
 
+  class Reclaimer;
+  class DiffCursor;
+
   struct Node
   {
     T data;
@@ -48,17 +83,42 @@ private:
     }
   };
 
+  //Количество поисков, которые ведутся одновременно в пакетном поиске
+  static constexpr size_t lookupGroupSize = 16;
+  //Во сколько раз кусков при разбиении дерева больше, чем частей
+  static constexpr size_t piecesPerChunk = 8;
+  //Во сколько раз частей при параллельном обходе больше, чем потоков
+  static constexpr size_t chunksPerThread = 4;
+  //Деревья не выше этого уровня (не больше 3^8 узлов) clear() удаляет сразу, без фонового потока
+  static constexpr int deferredClearLevel = 8;
+
   Node * root;
   Comparator compare;
+  //Количество узлов в дереве
+  size_t nodeCount;
+
+  //Фильтр Блума перед поиском, отсекает значения, которых точно нет в дереве
+  BloomFilter<T> filter;
+  bool isFilterEnabled;
 
   Node * insert(Node * node, const T & data);
   Node * skew(Node * node);
   Node * split(Node * node);
-  Node * remove(Node * node, const T & data);
+  Node * remove(Node * node, const T & data, bool & isRemoved);
   bool isLeaf(Node * node);
-  void deleteSubtree(Node * node);
+  static void deleteSubtree(Node * node);
+  static Reclaimer & getReclaimer();
   Node * amendLevel(Node * node);
-  size_t getSize(Node * node);
+  void findManyNodes(const std::vector<T> & keys, std::vector<Node *> & foundNodes);
+  static void prefetch(const Node * node);
+  void rebuildFilter();
+  void addSubtreeToFilter(Node * node);
+  static Node * buildSubtree(std::vector<T> & values, size_t first, size_t last);
+  static bool isStrictlyIncreasing(const std::vector<T> & values);
+  static void appendVarint(std::vector<uint8_t> & bytes, uint64_t value);
+  static uint64_t readVarint(const std::vector<uint8_t> & bytes, size_t & position);
+  static void appendValues(std::vector<uint8_t> & bytes, const std::vector<T> & values);
+  static void readValues(const std::vector<uint8_t> & bytes, size_t & position, std::vector<T> & values);
 };
 
 //Создаём класс итератор для перемещения по узлам дерева в порядке от меньшего к большему
@@ -307,7 +367,7 @@ typename AATree<T>::Node * AATree<T>::Iterator::getParent(Node * ancestor, Node
     return ancestor;
   }
 
-  if (AATree<T>::compare(child->data, ancestor->data))
+  if (Comparator()(child->data, ancestor->data))
   {
     return getParent(ancestor->left, child);
   }
@@ -322,17 +382,256 @@ typename AATree<T>::Node * AATree<T>::Iterator::getParent(Node * ancestor, Node
 template <typename T>
 class AATree<T>::Comparator : public std::less<T> {};
 
+//Класс для части дерева - непрерывного диапазона значений в порядке возрастания
+//Диапазон состоит из целых поддеревьев и отдельных узлов между ними
+template <typename T>
+class AATree<T>::Chunk
+{
+public:
+  friend class AATree<T>;
+
+  template <typename Function>
+  void forEach(Function function);
+
+private:
+  struct Piece
+  {
+    Node * node;
+    //true - всё поддерево с корнем node, false - только сам узел
+    bool isSubtree;
+  };
+
+  std::vector<Piece> pieces;
+};
+
+//Обход значений части дерева в порядке возрастания
+template <typename T>
+template <typename Function>
+void AATree<T>::Chunk::forEach(Function function)
+{
+  std::vector<Node *> stack;
+
+  for (const Piece & piece : pieces)
+  {
+    if (!piece.isSubtree)
+    {
+      function(piece.node->data);
+      continue;
+    }
+
+    //Обход поддерева без рекурсии, с явным стеком
+    Node * currNode = piece.node;
+    while (currNode != nullptr || !stack.empty())
+    {
+      while (currNode != nullptr)
+      {
+        stack.push_back(currNode);
+        currNode = currNode->left;
+      }
+      currNode = stack.back();
+      stack.pop_back();
+      function(currNode->data);
+      currNode = currNode->right;
+    }
+  }
+}
+
+//Класс для фонового удаления узлов
+//clear() передаёт ему отсоединённые деревья, а фоновый поток удаляет их по очереди
+//Используется только для значений с тривиальным деструктором
+template <typename T>
+class AATree<T>::Reclaimer
+{
+public:
+  Reclaimer();
+
+  void reclaim(Node * subtreeRoot);
+  void wait();
+
+private:
+  std::mutex mutex;
+  //Оповещение фонового потока о новых деревьях
+  std::condition_variable hasWork;
+  //Оповещение ожидающих о том, что очередь опустела
+  std::condition_variable isIdle;
+  std::vector<Node *> queue;
+  bool isBusy;
+  std::thread worker;
+
+  void run();
+};
+
+//Конструктор, запускает фоновый поток
+template <typename T>
+AATree<T>::Reclaimer::Reclaimer()
+{
+  isBusy = false;
+  worker = std::thread(&Reclaimer::run, this);
+}
+
+//Передача дерева на удаление в фоновый поток
+template <typename T>
+void AATree<T>::Reclaimer::reclaim(Node * subtreeRoot)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    queue.push_back(subtreeRoot);
+  }
+  hasWork.notify_one();
+}
+
+//Ожидание, пока все переданные деревья не будут удалены
+template <typename T>
+void AATree<T>::Reclaimer::wait()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  isIdle.wait(lock, [this]() { return queue.empty() && !isBusy; });
+}
+
+//Цикл фонового потока
+template <typename T>
+void AATree<T>::Reclaimer::run()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true)
+  {
+    hasWork.wait(lock, [this]() { return !queue.empty(); });
+
+    Node * subtreeRoot = queue.back();
+    queue.pop_back();
+    isBusy = true;
+
+    //Удаляем без блокировки, чтобы clear() в других потоках не ждал
+    lock.unlock();
+    deleteSubtree(subtreeRoot);
+    lock.lock();
+
+    isBusy = false;
+    if (queue.empty())
+    {
+      isIdle.notify_all();
+    }
+  }
+}
+
+//Разница между двумя деревьями: значения, которые нужно добавить и удалить,
+//чтобы из старого дерева получить новое. Оба списка упорядочены по возрастанию
+template <typename T>
+struct AATree<T>::Delta
+{
+  std::vector<T> added;
+  std::vector<T> removed;
+};
+
+//Курсор для обхода дерева в порядке возрастания при сравнении деревьев
+//В стеке лежат либо отдельные узлы, либо ещё не раскрытые поддеревья,
+//поэтому два курсора могут заметить общее поддерево и пропустить его целиком
+template <typename T>
+class AATree<T>::DiffCursor
+{
+public:
+  DiffCursor(Node * root);
+
+  bool isDone();
+  bool isAtSubtree();
+  Node * getNode();
+  void expand();
+  void skip();
+  void moveToNode();
+
+private:
+  struct Entry
+  {
+    Node * node;
+    bool isSubtree;
+  };
+
+  std::vector<Entry> stack;
+};
+
+//Конструктор курсора, начинает с целого дерева
+template <typename T>
+AATree<T>::DiffCursor::DiffCursor(Node * root)
+{
+  if (root != nullptr)
+  {
+    stack.push_back({ root, true });
+  }
+}
+
+//Проверка, закончился ли обход
+template <typename T>
+bool AATree<T>::DiffCursor::isDone()
+{
+  return stack.empty();
+}
+
+//Проверка, стоит ли курсор на нераскрытом поддереве
+template <typename T>
+bool AATree<T>::DiffCursor::isAtSubtree()
+{
+  return stack.back().isSubtree;
+}
+
+//Получение текущего узла (или корня текущего поддерева)
+template <typename T>
+typename AATree<T>::Node * AATree<T>::DiffCursor::getNode()
+{
+  return stack.back().node;
+}
+
+//Раскрытие текущего поддерева на левое поддерево, корень и правое поддерево
+template <typename T>
+void AATree<T>::DiffCursor::expand()
+{
+  Node * node = stack.back().node;
+  stack.pop_back();
+
+  if (node->right != nullptr)
+  {
+    stack.push_back({ node->right, true });
+  }
+  stack.push_back({ node, false });
+  if (node->left != nullptr)
+  {
+    stack.push_back({ node->left, true });
+  }
+}
+
+//Пропуск текущего узла или поддерева целиком
+template <typename T>
+void AATree<T>::DiffCursor::skip()
+{
+  stack.pop_back();
+}
+
+//Раскрытие поддеревьев, пока курсор не встанет на отдельный узел
+template <typename T>
+void AATree<T>::DiffCursor::moveToNode()
+{
+  while (!stack.empty() && stack.back().isSubtree)
+  {
+    expand();
+  }
+}
+
 //Конструктор без параметров
 template <typename T>
 AATree<T>::AATree()
 {
   this->root = nullptr;
+  this->nodeCount = 0;
+  this->isFilterEnabled = false;
 }
 
 //Конструктор со списком инициализации
 template <typename T>
 AATree<T>::AATree(std::initializer_list<T> list)
 {
+  this->root = nullptr;
+  this->nodeCount = 0;
+  this->isFilterEnabled = false;
+
   for (auto data: list)
   {
     insert(data);
@@ -360,6 +659,17 @@ template <typename T>
 void AATree<T>::insert(const T & data)
 {
   root = insert(root, data);
+  nodeCount++;
+
+  if (isFilterEnabled)
+  {
+    filter.add(data);
+    //Если элементов стало больше, чем рассчитан фильтр, перестраиваем его под новый размер
+    if (filter.isOverCapacity())
+    {
+      rebuildFilter();
+    }
+  }
 }
 
 template <typename T>
@@ -432,6 +742,12 @@ typename AATree<T>::Node * AATree<T>::split(Node * node)
 template <typename T>
 bool AATree<T>::contains(const T & data)
 {
+  //Если фильтр говорит, что значения нет, то спускаться по дереву не нужно
+  if (isFilterEnabled && !filter.mightContain(data))
+  {
+    return false;
+  }
+
   Node * currNode = root;
 
   bool isFound = false;
@@ -456,27 +772,166 @@ bool AATree<T>::contains(const T & data)
   return isFound;
 }
 
+//Пакетная проверка наличия значений в дереве
+//Результат i-го элемента соответствует i-му ключу
+template <typename T>
+std::vector<bool> AATree<T>::containsMany(const std::vector<T> & keys)
+{
+  std::vector<Node *> foundNodes;
+  findManyNodes(keys, foundNodes);
+
+  std::vector<bool> isFound(keys.size());
+  for (size_t i = 0; i < keys.size(); i++)
+  {
+    isFound[i] = (foundNodes[i] != nullptr);
+  }
+
+  return isFound;
+}
+
+//Пакетный поиск значений в дереве
+//Для отсутствующих значений возвращается end()
+template <typename T>
+std::vector<typename AATree<T>::Iterator> AATree<T>::findMany(const std::vector<T> & keys)
+{
+  std::vector<Node *> foundNodes;
+  findManyNodes(keys, foundNodes);
+
+  std::vector<Iterator> iterators;
+  iterators.reserve(keys.size());
+  for (Node * node : foundNodes)
+  {
+    iterators.push_back(Iterator(node, root));
+  }
+
+  return iterators;
+}
+
+//Внутренний метод пакетного поиска
+//Ключи обрабатываются группами: спуски внутри группы независимы, поэтому идём по ним
+//поочерёдно, на каждом шаге заранее подгружая в кэш следующий узел каждого спуска.
+//Пока обрабатываются остальные спуски группы, узел успевает загрузиться из памяти
+template <typename T>
+void AATree<T>::findManyNodes(const std::vector<T> & keys, std::vector<Node *> & foundNodes)
+{
+  foundNodes.assign(keys.size(), nullptr);
+
+  Node * cursors[lookupGroupSize];
+
+  for (size_t groupStart = 0; groupStart < keys.size(); groupStart += lookupGroupSize)
+  {
+    size_t groupSize = std::min(lookupGroupSize, keys.size() - groupStart);
+
+    //Количество спусков, которые ещё не завершились
+    size_t activeCount = groupSize;
+
+    for (size_t i = 0; i < groupSize; i++)
+    {
+      cursors[i] = root;
+      //Значения, которых точно нет по фильтру, не ищем
+      if (root == nullptr || (isFilterEnabled && !filter.mightContain(keys[groupStart + i])))
+      {
+        cursors[i] = nullptr;
+        activeCount--;
+      }
+    }
+    prefetch(root);
+
+    while (activeCount > 0)
+    {
+      for (size_t i = 0; i < groupSize; i++)
+      {
+        Node * currNode = cursors[i];
+        if (currNode == nullptr)
+        {
+          continue;
+        }
+
+        const T & key = keys[groupStart + i];
+        if (compare(key, currNode->data))
+        {
+          currNode = currNode->left;
+        }
+        else if (compare(currNode->data, key))
+        {
+          currNode = currNode->right;
+        }
+        else
+        {
+          //Нашли значение, спуск завершён
+          foundNodes[groupStart + i] = currNode;
+          currNode = nullptr;
+        }
+
+        if (currNode == nullptr)
+        {
+          activeCount--;
+        }
+        else
+        {
+          prefetch(currNode);
+        }
+        cursors[i] = currNode;
+      }
+    }
+  }
+}
+
+//Подсказка процессору заранее загрузить узел в кэш
+template <typename T>
+void AATree<T>::prefetch(const Node * node)
+{
+#if defined(_MSC_VER)
+  _mm_prefetch(reinterpret_cast<const char *>(node), _MM_HINT_T0);
+#else
+  __builtin_prefetch(node);
+#endif
+}
+
 //Пользовательский метод для удаления узла с заданным значением
 template <typename T>
 void AATree<T>::remove(const T & data)
 {
+  //Если значения точно нет в дереве, удалять нечего
+  if (isFilterEnabled && !filter.mightContain(data))
+  {
+    return;
+  }
+
   //Вызываем внутренний метод для удаления узла с заданным значением
-  root = remove(root, data);
+  bool isRemoved = false;
+  root = remove(root, data, isRemoved);
+  if (isRemoved)
+  {
+    nodeCount--;
+  }
+
+  //Учитываем только действительно удалённые значения
+  if (isFilterEnabled && isRemoved)
+  {
+    //Удалённое значение остаётся в фильтре, поэтому после многих удалений фильтр перестраиваем
+    filter.markRemoved();
+    if (filter.isStale())
+    {
+      rebuildFilter();
+    }
+  }
 }
 
 //Внутренний метод для удаления узла с заданным значением
+//isRemoved становится true, если узел с таким значением был найден и удалён
 template <typename T>
-typename AATree<T>::Node * AATree<T>::remove(Node * node, const T & data)
+typename AATree<T>::Node * AATree<T>::remove(Node * node, const T & data, bool & isRemoved)
 {
   if (node != nullptr)
   { //Пока не нашлось нужное значение, идем по узлам вниз
     if (compare(data, node->data))
     {
-      node->left = remove(node->left, data);
+      node->left = remove(node->left, data, isRemoved);
     }
     else if (compare(node->data, data))
     {
-      node->right = remove(node->right, data);
+      node->right = remove(node->right, data, isRemoved);
     }
     //Если нашелся узел с нужным значением
     else
@@ -486,6 +941,7 @@ typename AATree<T>::Node * AATree<T>::remove(Node * node, const T & data)
       {
         //Удаляем узел
         delete node;
+        isRemoved = true;
         return nullptr;
       }
       //2 случай: Если у узла нет левого поддерева
@@ -498,7 +954,7 @@ typename AATree<T>::Node * AATree<T>::remove(Node * node, const T & data)
           successor = successor->left;
         }
         node->data = successor->data;
-        node->right = remove(node->right, successor->data);
+        node->right = remove(node->right, successor->data, isRemoved);
       }
       //3 случай: Если у узла есть левое поддерево
       else
@@ -510,7 +966,7 @@ typename AATree<T>::Node * AATree<T>::remove(Node * node, const T & data)
           predecessor = predecessor->right;
         }
         node->data = predecessor->data;
-        node->left = remove(node->left, predecessor->data);
+        node->left = remove(node->left, predecessor->data, isRemoved);
       }
     }
 
@@ -582,27 +1038,125 @@ typename AATree<T>::Node * AATree<T>::amendLevel(Node * node)
 }
 
 //Удаление целого дерева
+//Дерево отсоединяется сразу. Если у значений тривиальный деструктор, узлы большого дерева
+//удаляются в фоновом потоке, и clear() (и деструктор) не ждёт освобождения памяти.
+//Значения с нетривиальным деструктором (файлы, блокировки и т.п.) всегда удаляются сразу,
+//в текущем потоке, чтобы их деструкторы выполнялись там и тогда, где этого ждёт владелец
 template <typename T>
 void AATree<T>::clear()
 {
-  //Вызов внутренней рекурсивной функции, удаляющей поддеревья
-  deleteSubtree(root);
+  Node * oldRoot = root;
+  root = nullptr;
+  nodeCount = 0;
+
+  if (isFilterEnabled)
+  {
+    filter.clear();
+  }
+
+  if (oldRoot == nullptr)
+  {
+    return;
+  }
+
+  if constexpr (std::is_trivially_destructible<T>::value)
+  {
+    //Маленькое дерево быстрее удалить сразу, чем передавать в другой поток
+    if (oldRoot->level > deferredClearLevel)
+    {
+      getReclaimer().reclaim(oldRoot);
+      return;
+    }
+  }
+
+  deleteSubtree(oldRoot);
 }
 
-//Удаление поддерева
+//Ожидание, пока фоновый поток не удалит узлы всех очищенных деревьев
 template <typename T>
-void AATree<T>::deleteSubtree(Node * node)
+void AATree<T>::waitForReclamation()
+{
+  //Деревья с нетривиальными деструкторами значений в фоновый поток не передаются
+  if constexpr (std::is_trivially_destructible<T>::value)
+  {
+    getReclaimer().wait();
+  }
+}
+
+//Получение объекта фонового удаления, общего для всех деревьев с данным типом значений
+//Объект создаётся при первом обращении и намеренно не уничтожается: деревья в статических
+//переменных могут очищаться при завершении программы уже после разрушения статических объектов
+template <typename T>
+typename AATree<T>::Reclaimer & AATree<T>::getReclaimer()
+{
+  static Reclaimer * reclaimer = new Reclaimer();
+
+  return *reclaimer;
+}
+
+//Включение фильтра для быстрого отсечения отсутствующих значений
+//falsePositiveRate - допустимая доля отсутствующих значений, которые фильтр пропустит к поиску в дереве
+//memoryBudget - ограничение памяти фильтра в байтах (0 - без ограничения)
+template <typename T>
+void AATree<T>::enableFilter(double falsePositiveRate, size_t memoryBudget)
+{
+  static_assert(BloomFilter<T>::isSupported, "Filter requires std::hash for the element type.");
+
+  filter.configure(getSize(), falsePositiveRate, memoryBudget);
+  isFilterEnabled = true;
+  addSubtreeToFilter(root);
+}
+
+//Выключение фильтра с освобождением его памяти
+template <typename T>
+void AATree<T>::disableFilter()
+{
+  filter = BloomFilter<T>();
+  isFilterEnabled = false;
+}
+
+//Перестроение фильтра по текущему содержимому дерева
+//Ёмкость берём с запасом, чтобы при дальнейших вставках фильтр перестраивался не сразу
+template <typename T>
+void AATree<T>::rebuildFilter()
+{
+  filter.configure(2 * getSize(), filter.getFalsePositiveRate(), filter.getMemoryBudget());
+  addSubtreeToFilter(root);
+}
+
+//Добавление в фильтр всех значений поддерева
+template <typename T>
+void AATree<T>::addSubtreeToFilter(Node * node)
 {
   if (node != nullptr)
   {
-    //Удаление поддерева слева
-    deleteSubtree(node->left);
-    //Удаление поддерева справа
-    deleteSubtree(node->right);
+    addSubtreeToFilter(node->left);
+    filter.add(node->data);
+    addSubtreeToFilter(node->right);
+  }
+}
 
-    //Удаление узла
-    delete node;
-    node = nullptr;
+//Удаление поддерева без рекурсии и дополнительной памяти
+//Пока у узла есть левый сын, поворачиваем вправо; когда левого сына нет,
+//удаляем узел и переходим к правому сыну
+template <typename T>
+void AATree<T>::deleteSubtree(Node * node)
+{
+  while (node != nullptr)
+  {
+    if (node->left != nullptr)
+    {
+      Node * leftChild = node->left;
+      node->left = leftChild->right;
+      leftChild->right = node;
+      node = leftChild;
+    }
+    else
+    {
+      Node * rightChild = node->right;
+      delete node;
+      node = rightChild;
+    }
   }
 }
 
@@ -611,6 +1165,9 @@ template <typename T>
 void AATree<T>::swap(AATree & firstTree, AATree & secondTree)
 {
   std::swap(firstTree.root, secondTree.root);
+  std::swap(firstTree.nodeCount, secondTree.nodeCount);
+  std::swap(firstTree.filter, secondTree.filter);
+  std::swap(firstTree.isFilterEnabled, secondTree.isFilterEnabled);
 }
 
 //Проверка, является ли дерево пустым
@@ -635,24 +1192,7 @@ bool AATree<T>::isEmpty()
 template <typename T>
 size_t AATree<T>::getSize()
 {
-  //Вызов внутреннего рекурсивного метода
-  size_t size = getSize(root);
-
-  return size;
-}
-
-//Внутренний рекурсивный метод для нахождения количества узлов
-template <typename T>
-size_t AATree<T>::getSize(Node * node)
-{
-  size_t size = 0;
-
-  if (node != nullptr)
-  {
-    size = getSize(node->left) + getSize(node->right) + 1;
-  }
-
-  return size;
+  return nodeCount;
 }
 
 //Получение итератора, указывающего на первый (наименьший) элемент в дереве
@@ -679,3 +1219,531 @@ AATree<T>::Iterator AATree<T>::end()
 {
   return Iterator(nullptr, root);
 }
+
+//Разбиение дерева на chunkCount частей примерно одинакового размера
+//Части идут по возрастанию значений и вместе покрывают всё дерево
+//Размер поддерева оцениваем по его уровню, чтобы не обходить дерево целиком
+template <typename T>
+std::vector<typename AATree<T>::Chunk> AATree<T>::partition(size_t chunkCount)
+{
+  std::vector<Chunk> chunks;
+  if (root == nullptr || chunkCount == 0)
+  {
+    return chunks;
+  }
+
+  //Разбиваем дерево на куски: все самые высокие поддеревья заменяем
+  //на левое поддерево, корень и правое поддерево. Кусков делаем с запасом,
+  //чтобы ошибка оценки размера каждого куска меньше влияла на размеры частей
+  std::vector<typename Chunk::Piece> pieces;
+  pieces.push_back({ root, true });
+
+  while (pieces.size() < piecesPerChunk * chunkCount)
+  {
+    int maxLevel = 0;
+    for (const typename Chunk::Piece & piece : pieces)
+    {
+      if (piece.isSubtree && !isLeaf(piece.node))
+      {
+        maxLevel = std::max(maxLevel, piece.node->level);
+      }
+    }
+    //Больше нечего разбивать
+    if (maxLevel == 0)
+    {
+      break;
+    }
+
+    std::vector<typename Chunk::Piece> expandedPieces;
+    expandedPieces.reserve(3 * pieces.size());
+    for (const typename Chunk::Piece & piece : pieces)
+    {
+      Node * node = piece.node;
+      if (!piece.isSubtree || isLeaf(node) || node->level != maxLevel)
+      {
+        expandedPieces.push_back(piece);
+        continue;
+      }
+
+      if (node->left != nullptr)
+      {
+        expandedPieces.push_back({ node->left, true });
+      }
+      expandedPieces.push_back({ node, false });
+      if (node->right != nullptr)
+      {
+        expandedPieces.push_back({ node->right, true });
+      }
+    }
+    pieces.swap(expandedPieces);
+  }
+
+  //Оценка размера куска: поддерево уровня L содержит не меньше 2^L - 1 узлов
+  std::vector<double> weights(pieces.size());
+  double totalWeight = 0;
+  for (size_t i = 0; i < pieces.size(); i++)
+  {
+    Node * node = pieces[i].node;
+    weights[i] = 1.0;
+    if (pieces[i].isSubtree)
+    {
+      weights[i] = static_cast<double>((size_t(1) << node->level) - 1);
+      //Правый сын того же уровня (горизонтальное ребро) добавляет ещё примерно половину
+      if (node->right != nullptr && node->right->level == node->level)
+      {
+        weights[i] += static_cast<double>(size_t(1) << (node->level - 1));
+      }
+    }
+    totalWeight += weights[i];
+  }
+
+  //Распределяем куски по частям подряд, закрывая часть, когда набран её вес
+  chunks.emplace_back();
+  double accumulatedWeight = 0;
+  for (size_t i = 0; i < pieces.size(); i++)
+  {
+    double chunkLimit = totalWeight * chunks.size() / chunkCount;
+    if (!chunks.back().pieces.empty() && chunks.size() < chunkCount
+      && accumulatedWeight + weights[i] / 2 > chunkLimit)
+    {
+      chunks.emplace_back();
+    }
+    chunks.back().pieces.push_back(pieces[i]);
+    accumulatedWeight += weights[i];
+  }
+
+  return chunks;
+}
+
+//Параллельный обход дерева: дерево разбивается на части, и потоки разбирают их по очереди
+//Частей больше, чем потоков, поэтому потоки, которым достались части поменьше, берут следующие
+//Внутри части значения обрабатываются по возрастанию, порядок между частями не определён
+//function вызывается одновременно из нескольких потоков и должна это допускать
+//threadCount = 0 - по количеству ядер процессора
+template <typename T>
+template <typename Function>
+void AATree<T>::parallelForEach(Function function, size_t threadCount)
+{
+  if (threadCount == 0)
+  {
+    threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+
+  std::vector<Chunk> chunks = partition(threadCount * chunksPerThread);
+  if (chunks.empty())
+  {
+    return;
+  }
+  threadCount = std::min(threadCount, chunks.size());
+
+  //Номер следующей необработанной части
+  std::atomic<size_t> nextChunk(0);
+  //Исключение из потока сохраняем и пробрасываем после завершения всех потоков
+  std::vector<std::exception_ptr> errors(threadCount);
+
+  auto processChunks = [&](size_t threadIndex) {
+    try
+    {
+      for (size_t index = nextChunk++; index < chunks.size(); index = nextChunk++)
+      {
+        chunks[index].forEach(function);
+      }
+    }
+    catch (...)
+    {
+      errors[threadIndex] = std::current_exception();
+      //Остальные части уже не обрабатываем
+      nextChunk = chunks.size();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(threadCount - 1);
+  for (size_t i = 1; i < threadCount; i++)
+  {
+    threads.emplace_back(processChunks, i);
+  }
+  //Текущий поток тоже разбирает части
+  processChunks(0);
+
+  for (std::thread & thread : threads)
+  {
+    thread.join();
+  }
+
+  for (const std::exception_ptr & error : errors)
+  {
+    if (error)
+    {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+//Сравнение двух деревьев за O(n + m): два курсора идут по деревьям в порядке возрастания,
+//как при слиянии упорядоченных последовательностей
+//Если деревья разделяют поддеревья (одни и те же узлы), такие поддеревья пропускаются без обхода
+template <typename T>
+typename AATree<T>::Delta AATree<T>::diff(AATree & oldTree, AATree & newTree)
+{
+  Delta delta;
+  DiffCursor oldCursor(oldTree.root);
+  DiffCursor newCursor(newTree.root);
+  Comparator compare;
+
+  while (!oldCursor.isDone() && !newCursor.isDone())
+  {
+    bool isOldSubtree = oldCursor.isAtSubtree();
+    bool isNewSubtree = newCursor.isAtSubtree();
+
+    //1 случай: Оба курсора на одном и том же поддереве, в нём нет различий
+    if (isOldSubtree && isNewSubtree && oldCursor.getNode() == newCursor.getNode())
+    {
+      oldCursor.skip();
+      newCursor.skip();
+    }
+    //2 случай: Хотя бы один курсор на поддереве, раскрываем более высокое,
+    //чтобы быстрее дойти до возможного общего поддерева
+    else if (isOldSubtree || isNewSubtree)
+    {
+      if (isOldSubtree && (!isNewSubtree || oldCursor.getNode()->level >= newCursor.getNode()->level))
+      {
+        oldCursor.expand();
+      }
+      else
+      {
+        newCursor.expand();
+      }
+    }
+    //3 случай: Оба курсора на узлах, сравниваем значения
+    else
+    {
+      const T & oldData = oldCursor.getNode()->data;
+      const T & newData = newCursor.getNode()->data;
+
+      if (compare(oldData, newData))
+      {
+        delta.removed.push_back(oldData);
+        oldCursor.skip();
+      }
+      else if (compare(newData, oldData))
+      {
+        delta.added.push_back(newData);
+        newCursor.skip();
+      }
+      else
+      {
+        oldCursor.skip();
+        newCursor.skip();
+      }
+    }
+  }
+
+  //Оставшиеся значения старого дерева удалены, нового - добавлены
+  for (oldCursor.moveToNode(); !oldCursor.isDone(); oldCursor.moveToNode())
+  {
+    delta.removed.push_back(oldCursor.getNode()->data);
+    oldCursor.skip();
+  }
+  for (newCursor.moveToNode(); !newCursor.isDone(); newCursor.moveToNode())
+  {
+    delta.added.push_back(newCursor.getNode()->data);
+    newCursor.skip();
+  }
+
+  return delta;
+}
+
+//Кодирование разницы в компактный двоичный формат:
+//сигнатура "AAD" и версия, количество удалённых и добавленных значений, затем сами значения
+//Целые числа записываются как разности соседних значений переменной длины (varint),
+//остальные тривиально копируемые типы - побайтово
+template <typename T>
+std::vector<uint8_t> AATree<T>::encodeDelta(const Delta & delta)
+{
+  std::vector<uint8_t> bytes = { 'A', 'A', 'D', 1 };
+
+  appendVarint(bytes, delta.removed.size());
+  appendVarint(bytes, delta.added.size());
+  appendValues(bytes, delta.removed);
+  appendValues(bytes, delta.added);
+
+  return bytes;
+}
+
+//Декодирование разницы из двоичного формата
+template <typename T>
+typename AATree<T>::Delta AATree<T>::decodeDelta(const std::vector<uint8_t> & bytes)
+{
+  if (bytes.size() < 4 || bytes[0] != 'A' || bytes[1] != 'A' || bytes[2] != 'D' || bytes[3] != 1)
+  {
+    throw std::invalid_argument("Error: Invalid delta format.\n");
+  }
+
+  size_t position = 4;
+  uint64_t removedCount = readVarint(bytes, position);
+  uint64_t addedCount = readVarint(bytes, position);
+
+  //Каждое значение занимает хотя бы один байт, поэтому заведомо неверные размеры отсекаем сразу
+  if (removedCount > bytes.size() || addedCount > bytes.size())
+  {
+    throw std::invalid_argument("Error: Invalid delta format.\n");
+  }
+
+  Delta delta;
+  delta.removed.resize(removedCount);
+  delta.added.resize(addedCount);
+  readValues(bytes, position, delta.removed);
+  readValues(bytes, position, delta.added);
+
+  //Списки в разнице упорядочены строго по возрастанию, иначе данные повреждены
+  if (position != bytes.size() || !isStrictlyIncreasing(delta.removed) || !isStrictlyIncreasing(delta.added))
+  {
+    throw std::invalid_argument("Error: Invalid delta format.\n");
+  }
+
+  return delta;
+}
+
+//Применение разницы к дереву
+//Небольшие изменения вносятся по одному, а при большом количестве изменений
+//дерево собирается заново слиянием упорядоченных списков за O(n + m)
+//Отсутствующие в дереве удаляемые значения пропускаются, а если добавляемое значение уже есть
+//и не удаляется этой же разницей, бросается исключение - в обоих случаях дерево не меняется
+template <typename T>
+void AATree<T>::applyDelta(const Delta & delta)
+{
+  if (!isStrictlyIncreasing(delta.added) || !isStrictlyIncreasing(delta.removed))
+  {
+    throw std::invalid_argument("Error: Delta values must be strictly increasing.\n");
+  }
+
+  size_t changeCount = delta.added.size() + delta.removed.size();
+  if (changeCount == 0)
+  {
+    return;
+  }
+
+  //Проверяем добавляемые значения до любых изменений, чтобы ошибка не оставила дерево изменённым наполовину
+  std::vector<bool> isFound = containsMany(delta.added);
+  for (size_t i = 0; i < delta.added.size(); i++)
+  {
+    if (isFound[i] && !std::binary_search(delta.removed.begin(), delta.removed.end(), delta.added[i], compare))
+    {
+      throw std::logic_error("Error: Element already exists.\n");
+    }
+  }
+
+  //Дерево перестраивается целиком, только если изменений не меньше, чем узлов в дереве:
+  //по замерам пересборка стоит примерно как вставка или удаление того же числа значений по одному
+  bool isLargeDelta = (changeCount >= nodeCount);
+
+  if (!isLargeDelta)
+  {
+    for (const T & data : delta.removed)
+    {
+      remove(data);
+    }
+    for (const T & data : delta.added)
+    {
+      insert(data);
+    }
+    return;
+  }
+
+  //Сливаем значения дерева с добавленными, пропуская удалённые
+  //Значение, которое удаляется и добавляется заново, попадает в результат из списка добавленных
+  std::vector<T> values;
+  Chunk wholeTree;
+  if (root != nullptr)
+  {
+    wholeTree.pieces.push_back({ root, true });
+  }
+
+  size_t addedIndex = 0;
+  size_t removedIndex = 0;
+  auto appendAdded = [&](const T & bound, bool hasBound) {
+    while (addedIndex < delta.added.size() && (!hasBound || compare(delta.added[addedIndex], bound)))
+    {
+      values.push_back(delta.added[addedIndex]);
+      addedIndex++;
+    }
+  };
+
+  wholeTree.forEach([&](T & data) {
+    appendAdded(data, true);
+
+    while (removedIndex < delta.removed.size() && compare(delta.removed[removedIndex], data))
+    {
+      removedIndex++;
+    }
+    if (removedIndex < delta.removed.size() && !compare(data, delta.removed[removedIndex]))
+    {
+      removedIndex++;
+      return;
+    }
+
+    values.push_back(data);
+  });
+  appendAdded(T(), false);
+
+  clear();
+  root = buildSubtree(values, 0, values.size());
+  nodeCount = values.size();
+
+  if (isFilterEnabled)
+  {
+    rebuildFilter();
+  }
+}
+
+//Построение сбалансированного АА-дерева из упорядоченных значений [first, last)
+//Корень - середина диапазона, уровень узла - floor(log2(n + 1)) для поддерева из n узлов:
+//левое поддерево всегда ровно на уровень ниже, правое - на уровень ниже или того же уровня
+template <typename T>
+typename AATree<T>::Node * AATree<T>::buildSubtree(std::vector<T> & values, size_t first, size_t last)
+{
+  if (first == last)
+  {
+    return nullptr;
+  }
+
+  size_t middle = first + (last - first - 1) / 2;
+  Node * node = new Node(values[middle]);
+  node->left = buildSubtree(values, first, middle);
+  node->right = buildSubtree(values, middle + 1, last);
+
+  int level = 0;
+  for (size_t size = last - first + 1; size > 1; size /= 2)
+  {
+    level++;
+  }
+  node->level = level;
+
+  return node;
+}
+
+//Проверка, что значения упорядочены строго по возрастанию, как в разнице двух деревьев
+template <typename T>
+bool AATree<T>::isStrictlyIncreasing(const std::vector<T> & values)
+{
+  for (size_t i = 1; i < values.size(); i++)
+  {
+    if (!Comparator()(values[i - 1], values[i]))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+//Запись беззнакового числа переменной длины: по 7 бит в байте, старший бит - признак продолжения
+template <typename T>
+void AATree<T>::appendVarint(std::vector<uint8_t> & bytes, uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    bytes.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  bytes.push_back(static_cast<uint8_t>(value));
+}
+
+//Чтение беззнакового числа переменной длины
+template <typename T>
+uint64_t AATree<T>::readVarint(const std::vector<uint8_t> & bytes, size_t & position)
+{
+  uint64_t value = 0;
+
+  for (int shift = 0; shift < 64; shift += 7)
+  {
+    if (position >= bytes.size())
+    {
+      throw std::invalid_argument("Error: Invalid delta format.\n");
+    }
+
+    uint8_t byte = bytes[position++];
+    //В десятом байте помещается только старший бит 64-битного числа
+    if (shift == 63 && (byte & 0x7f) > 1)
+    {
+      throw std::invalid_argument("Error: Invalid delta format.\n");
+    }
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0)
+    {
+      return value;
+    }
+  }
+
+  throw std::invalid_argument("Error: Invalid delta format.\n");
+}
+
+//Запись упорядоченного списка значений
+template <typename T>
+void AATree<T>::appendValues(std::vector<uint8_t> & bytes, const std::vector<T> & values)
+{
+  if constexpr (std::is_integral<T>::value && !std::is_same<T, bool>::value)
+  {
+    //Разности считаем в беззнаковом типе: для упорядоченных значений они неотрицательны и малы
+    //Знаковые значения сдвигаем на минимум типа, чтобы порядок сохранился и разности не переполнялись
+    typedef typename std::make_unsigned<T>::type Unsigned;
+    const Unsigned offset = static_cast<Unsigned>(std::numeric_limits<T>::min());
+    Unsigned previous = 0;
+    for (const T & data : values)
+    {
+      Unsigned current = static_cast<Unsigned>(static_cast<Unsigned>(data) - offset);
+      appendVarint(bytes, static_cast<Unsigned>(current - previous));
+      previous = current;
+    }
+  }
+  else
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "Delta encoding requires a trivially copyable type.");
+
+    size_t offset = bytes.size();
+    bytes.resize(offset + values.size() * sizeof(T));
+    if (!values.empty())
+    {
+      std::memcpy(bytes.data() + offset, values.data(), values.size() * sizeof(T));
+    }
+  }
+}
+
+//Чтение упорядоченного списка значений, размер списка задан заранее
+template <typename T>
+void AATree<T>::readValues(const std::vector<uint8_t> & bytes, size_t & position, std::vector<T> & values)
+{
+  if constexpr (std::is_integral<T>::value && !std::is_same<T, bool>::value)
+  {
+    typedef typename std::make_unsigned<T>::type Unsigned;
+    const Unsigned offset = static_cast<Unsigned>(std::numeric_limits<T>::min());
+    Unsigned previous = 0;
+    for (T & data : values)
+    {
+      //Разность, которая не помещается в тип или выводит значение за его пределы, означает повреждённые данные
+      uint64_t gap = readVarint(bytes, position);
+      if (gap > static_cast<uint64_t>(std::numeric_limits<Unsigned>::max() - previous))
+      {
+        throw std::invalid_argument("Error: Invalid delta format.\n");
+      }
+      previous = static_cast<Unsigned>(previous + gap);
+      data = static_cast<T>(static_cast<Unsigned>(previous + offset));
+    }
+  }
+  else
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "Delta encoding requires a trivially copyable type.");
+
+    size_t size = values.size() * sizeof(T);
+    if (bytes.size() - position < size)
+    {
+      throw std::invalid_argument("Error: Invalid delta format.\n");
+    }
+    if (size != 0)
+    {
+      std::memcpy(values.data(), bytes.data() + position, size);
+    }
+    position += size;
+  }
+}
@@ -0,0 +1,395 @@
+﻿#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <string>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include "AATree.h"
+#include "BucketAATree.h"
+
+//Замер времени выполнения функции в секундах
+template <typename Function>
+double measureSeconds(Function function)
+{
+  auto start = std::chrono::steady_clock::now();
+  function();
+  auto finish = std::chrono::steady_clock::now();
+
+  return std::chrono::duration<double>(finish - start).count();
+}
+
+//Заполнение дерева чётными числами 0, 2, ..., 2 * (count - 1) в случайном порядке
+void fillTree(AATree<long long> & tree, size_t count, std::mt19937_64 & generator)
+{
+  std::vector<long long> values(count);
+  for (size_t i = 0; i < count; i++)
+  {
+    values[i] = 2 * static_cast<long long>(i);
+  }
+  std::shuffle(values.begin(), values.end(), generator);
+
+  for (long long value : values)
+  {
+    tree.insert(value);
+  }
+}
+
+//Генерация ключей для поиска: доля hitRatio ключей есть в дереве (чётные), остальные - нет (нечётные)
+std::vector<long long> makeQueries(size_t treeSize, size_t queryCount, double hitRatio, std::mt19937_64 & generator)
+{
+  std::uniform_int_distribution<long long> valueDistribution(0, static_cast<long long>(treeSize) - 1);
+  std::bernoulli_distribution hitDistribution(hitRatio);
+
+  std::vector<long long> queries(queryCount);
+  for (size_t i = 0; i < queryCount; i++)
+  {
+    long long value = 2 * valueDistribution(generator);
+    queries[i] = hitDistribution(generator) ? value : value + 1;
+  }
+
+  return queries;
+}
+
+//Сравнение одиночного contains() с пакетным containsMany()
+void benchmarkBatchedLookups(AATree<long long> & tree, size_t treeSize, std::mt19937_64 & generator)
+{
+  std::cout << "\nBatched lookups\n";
+
+  const size_t queryCount = 2000000;
+  std::vector<long long> queries = makeQueries(treeSize, queryCount, 0.5, generator);
+
+  size_t singleHits = 0;
+  double singleSeconds = measureSeconds([&]() {
+    for (long long query : queries) {
+      singleHits += tree.contains(query) ? 1 : 0;
+    }
+  });
+
+  size_t batchHits = 0;
+  double batchSeconds = measureSeconds([&]() {
+    //Запросы приходят пачками по несколько тысяч ключей
+    const size_t batchSize = 4096;
+    std::vector<long long> batch;
+    for (size_t start = 0; start < queries.size(); start += batchSize) {
+      size_t finish = std::min(start + batchSize, queries.size());
+      batch.assign(queries.begin() + start, queries.begin() + finish);
+      std::vector<bool> isFound = tree.containsMany(batch);
+      batchHits += std::count(isFound.begin(), isFound.end(), true);
+    }
+  });
+
+  std::cout << "contains():     " << queryCount / singleSeconds / 1e6 << " M lookups/s\n";
+  std::cout << "containsMany(): " << queryCount / batchSeconds / 1e6 << " M lookups/s\n";
+  std::cout << "Hits match: " << (singleHits == batchHits ? "true" : "false") << " (expected: true)\n";
+}
+
+//Сравнение contains() без фильтра и с фильтром при разной доле найденных значений
+void benchmarkFilter(AATree<long long> & tree, size_t treeSize, std::mt19937_64 & generator)
+{
+  std::cout << "\nNegative-lookup filter\n";
+
+  const size_t queryCount = 1000000;
+  const double hitRatios[] = { 0.0, 0.25, 0.5, 0.75, 1.0 };
+  const double falsePositiveRates[] = { 0.1, 0.01, 0.001 };
+
+  for (double falsePositiveRate : falsePositiveRates) {
+    std::cout << "False positive rate " << falsePositiveRate << ":\n";
+
+    for (double hitRatio : hitRatios) {
+      std::vector<long long> queries = makeQueries(treeSize, queryCount, hitRatio, generator);
+
+      tree.disableFilter();
+      size_t plainHits = 0;
+      double plainSeconds = measureSeconds([&]() {
+        for (long long query : queries) {
+          plainHits += tree.contains(query) ? 1 : 0;
+        }
+      });
+
+      tree.enableFilter(falsePositiveRate);
+      size_t filteredHits = 0;
+      double filteredSeconds = measureSeconds([&]() {
+        for (long long query : queries) {
+          filteredHits += tree.contains(query) ? 1 : 0;
+        }
+      });
+
+      std::cout << "  hit ratio " << hitRatio
+        << ": without filter " << queryCount / plainSeconds / 1e6 << " M lookups/s"
+        << ", with filter " << queryCount / filteredSeconds / 1e6 << " M lookups/s"
+        << (plainHits == filteredHits ? "" : " (results differ!)") << "\n";
+    }
+  }
+
+  //Ограничение памяти фильтра: 1 байт на элемент вместо ~1.2 байта, нужных для 1%
+  tree.enableFilter(0.01, treeSize);
+  std::vector<long long> misses = makeQueries(treeSize, queryCount, 0.0, generator);
+  size_t budgetHits = 0;
+  double budgetSeconds = measureSeconds([&]() {
+    for (long long query : misses) {
+      budgetHits += tree.contains(query) ? 1 : 0;
+    }
+  });
+  std::cout << "Memory budget " << treeSize << " bytes, hit ratio 0: "
+    << queryCount / budgetSeconds / 1e6 << " M lookups/s"
+    << (budgetHits == 0 ? "" : " (results differ!)") << "\n";
+
+  tree.disableFilter();
+}
+
+//Проверочная работа над значением при обходе: перемешивание битов числа
+uint64_t mixValue(uint64_t value)
+{
+  for (int round = 0; round < 4; round++)
+  {
+    value ^= value >> 31;
+    value *= 0x7fb5d329728ea185ULL;
+  }
+
+  return value;
+}
+
+//Сравнение обхода итератором и параллельного обхода на разном числе потоков
+void benchmarkParallelTraversal(AATree<long long> & tree)
+{
+  std::cout << "\nParallel traversal\n";
+
+  //Подсчёт значений с заданным свойством, к общему счётчику обращаемся редко
+  std::atomic<size_t> matches(0);
+  auto visit = [&](long long & value) {
+    if (mixValue(static_cast<uint64_t>(value)) % 64 == 0) {
+      matches.fetch_add(1, std::memory_order_relaxed);
+    }
+  };
+
+  double iteratorSeconds = measureSeconds([&]() {
+    for (auto it = tree.begin(); it != tree.end(); ++it) {
+      visit(*it);
+    }
+  });
+  size_t iteratorMatches = matches.exchange(0);
+  std::cout << "Iterator:  " << iteratorSeconds << " s\n";
+
+  double singleSeconds = 0;
+  size_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+  for (size_t threadCount = 1; threadCount <= std::max(maxThreads, static_cast<size_t>(8)); threadCount *= 2) {
+    double seconds = measureSeconds([&]() {
+      tree.parallelForEach(visit, threadCount);
+    });
+    if (threadCount == 1) {
+      singleSeconds = seconds;
+    }
+
+    std::cout << threadCount << " threads: " << seconds << " s, speedup " << singleSeconds / seconds
+      << (matches.exchange(0) == iteratorMatches ? "" : " (results differ!)") << "\n";
+  }
+}
+
+//Замер задержки clear() для большого дерева и времени фонового удаления узлов
+void benchmarkClear(size_t treeSize, std::mt19937_64 & generator)
+{
+  std::cout << "\nClear\n";
+
+  AATree<long long> tree;
+  fillTree(tree, treeSize, generator);
+
+  double clearSeconds = measureSeconds([&]() {
+    tree.clear();
+  });
+  double reclaimSeconds = measureSeconds([&]() {
+    AATree<long long>::waitForReclamation();
+  });
+
+  std::cout << "clear() returned after " << clearSeconds * 1e3 << " ms\n";
+  std::cout << "Background teardown finished " << reclaimSeconds * 1e3 << " ms later\n";
+  std::cout << "Tree is empty: " << (tree.isEmpty() ? "true" : "false") << " (expected: true)\n";
+}
+
+//Замер сравнения деревьев, кодирования разницы и её применения
+void benchmarkDiff(size_t treeSize, std::mt19937_64 & generator)
+{
+  std::cout << "\nDiff and delta\n";
+
+  //Новое дерево отличается от старого 1% значений: часть удалена, часть добавлена
+  std::vector<long long> values(treeSize);
+  for (size_t i = 0; i < treeSize; i++)
+  {
+    values[i] = 2 * static_cast<long long>(i);
+  }
+  std::shuffle(values.begin(), values.end(), generator);
+
+  AATree<long long> oldTree;
+  AATree<long long> newTree;
+  std::bernoulli_distribution isChanged(0.01);
+  for (long long value : values)
+  {
+    oldTree.insert(value);
+    newTree.insert(isChanged(generator) ? value + 1 : value);
+  }
+
+  AATree<long long>::Delta delta;
+  double diffSeconds = measureSeconds([&]() {
+    delta = AATree<long long>::diff(oldTree, newTree);
+  });
+
+  std::vector<uint8_t> bytes;
+  double encodeSeconds = measureSeconds([&]() {
+    bytes = AATree<long long>::encodeDelta(delta);
+  });
+
+  AATree<long long>::Delta decodedDelta;
+  double decodeSeconds = measureSeconds([&]() {
+    decodedDelta = AATree<long long>::decodeDelta(bytes);
+  });
+
+  double applySeconds = measureSeconds([&]() {
+    oldTree.applyDelta(decodedDelta);
+  });
+
+  size_t changeCount = delta.added.size() + delta.removed.size();
+  std::cout << "diff(): " << diffSeconds * 1e3 << " ms, "
+    << delta.added.size() << " added, " << delta.removed.size() << " removed\n";
+  std::cout << "Encoded delta: " << bytes.size() << " bytes (raw values: "
+    << changeCount * sizeof(long long) << " bytes), encode " << encodeSeconds * 1e3
+    << " ms, decode " << decodeSeconds * 1e3 << " ms\n";
+  std::cout << "applyDelta(): " << applySeconds * 1e3 << " ms\n";
+  std::cout << "Trees equal after apply: "
+    << (AATree<long long>::diff(oldTree, newTree).added.empty()
+      && AATree<long long>::diff(oldTree, newTree).removed.empty() ? "true" : "false")
+    << " (expected: true)\n";
+
+  //Полный снимок как разница с пустым деревом: пакетная сборка против вставки по одному
+  AATree<long long> emptyTree;
+  AATree<long long>::Delta snapshot = AATree<long long>::diff(emptyTree, newTree);
+
+  AATree<long long> bulkTree;
+  double bulkSeconds = measureSeconds([&]() {
+    bulkTree.applyDelta(snapshot);
+  });
+
+  AATree<long long> insertedTree;
+  double insertSeconds = measureSeconds([&]() {
+    for (long long value : snapshot.added) {
+      insertedTree.insert(value);
+    }
+  });
+
+  std::cout << "Snapshot of " << snapshot.added.size() << " values: applyDelta() " << bulkSeconds * 1e3
+    << " ms, insert() one by one " << insertSeconds * 1e3 << " ms\n";
+}
+
+//Ключ размером 32 байта для проверки деревьев на крупных ключах
+typedef std::array<uint64_t, 4> WideKey;
+
+//Преобразование числа в ключ нужного типа с сохранением порядка
+template <typename Key>
+Key makeKey(long long value)
+{
+  return static_cast<Key>(value);
+}
+
+template <>
+WideKey makeKey<WideKey>(long long value)
+{
+  return WideKey{ static_cast<uint64_t>(value), 0, 0, 0 };
+}
+
+//Замер вставки, поиска и обхода для дерева заданного типа
+template <typename Tree, typename Key>
+void benchmarkTree(const std::string & name, const std::vector<Key> & values, const std::vector<Key> & queries)
+{
+  Tree tree;
+
+  double insertSeconds = measureSeconds([&]() {
+    for (const Key & value : values) {
+      tree.insert(value);
+    }
+  });
+
+  size_t hits = 0;
+  double lookupSeconds = measureSeconds([&]() {
+    for (const Key & query : queries) {
+      hits += tree.contains(query) ? 1 : 0;
+    }
+  });
+
+  size_t visited = 0;
+  double traversalSeconds = measureSeconds([&]() {
+    for (auto it = tree.begin(); it != tree.end(); ++it) {
+      visited++;
+    }
+  });
+
+  std::cout << "  " << name
+    << ": insert " << values.size() / insertSeconds / 1e6 << " M/s"
+    << ", contains " << queries.size() / lookupSeconds / 1e6 << " M/s"
+    << ", traversal " << visited / traversalSeconds / 1e6 << " M/s"
+    << " (hits: " << hits << ")\n";
+}
+
+//Сравнение обычного дерева с деревом на блоках разного размера для ключа заданного типа
+template <typename Key>
+void benchmarkBucketSizes(size_t treeSize, std::mt19937_64 & generator)
+{
+  std::cout << "Key size " << sizeof(Key) << " bytes:\n";
+
+  std::vector<Key> values(treeSize);
+  for (size_t i = 0; i < treeSize; i++)
+  {
+    values[i] = makeKey<Key>(2 * static_cast<long long>(i));
+  }
+  std::shuffle(values.begin(), values.end(), generator);
+
+  std::vector<long long> rawQueries = makeQueries(treeSize, 1000000, 0.5, generator);
+  std::vector<Key> queries;
+  queries.reserve(rawQueries.size());
+  for (long long query : rawQueries)
+  {
+    queries.push_back(makeKey<Key>(query));
+  }
+
+  benchmarkTree<AATree<Key>>("AATree      ", values, queries);
+  benchmarkTree<BucketAATree<Key, 4>>("Bucket K=4  ", values, queries);
+  benchmarkTree<BucketAATree<Key, 8>>("Bucket K=8  ", values, queries);
+  benchmarkTree<BucketAATree<Key, 16>>("Bucket K=16 ", values, queries);
+  benchmarkTree<BucketAATree<Key, 32>>("Bucket K=32 ", values, queries);
+  benchmarkTree<BucketAATree<Key, 64>>("Bucket K=64 ", values, queries);
+}
+
+int main(int argc, char * argv[]) {
+  //Размер дерева можно передать первым аргументом
+  //По умолчанию дерево заметно больше кэша последнего уровня
+  size_t treeSize = 4000000;
+  if (argc > 1) {
+    treeSize = std::stoull(argv[1]);
+  }
+
+  std::mt19937_64 generator(2024);
+
+  AATree<long long> tree;
+  std::cout << "Building tree of " << treeSize << " elements\n";
+  double buildSeconds = measureSeconds([&]() {
+    fillTree(tree, treeSize, generator);
+  });
+  std::cout << "Build time: " << buildSeconds << " s\n";
+
+  benchmarkBatchedLookups(tree, treeSize, generator);
+  benchmarkFilter(tree, treeSize, generator);
+  benchmarkParallelTraversal(tree);
+  benchmarkClear(treeSize, generator);
+  benchmarkDiff(std::min(treeSize, static_cast<size_t>(1000000)), generator);
+
+  //Обход обычного дерева итератором ищет родителя от корня на каждом шаге,
+  //поэтому сравнение блочных деревьев ведём на дереве поменьше
+  size_t bucketTreeSize = std::min(treeSize, static_cast<size_t>(1000000));
+  std::cout << "\nBucketed tree, " << bucketTreeSize << " elements\n";
+  benchmarkBucketSizes<int>(bucketTreeSize, generator);
+  benchmarkBucketSizes<long long>(bucketTreeSize, generator);
+  benchmarkBucketSizes<WideKey>(bucketTreeSize, generator);
+
+  return 0;
+}
@@ -0,0 +1,246 @@
+﻿#pragma once
+
+#include <functional>
+#include <stdexcept>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <type_traits>
+
+//Фильтр Блума - вероятностная структура для проверки принадлежности элемента множеству
+//Может ошибаться только в одну сторону: ответ "нет" всегда точный, ответ "возможно есть" - нет
+//Удалять элементы из фильтра нельзя, поэтому удаления только подсчитываются,
+//а владелец фильтра сам решает, когда перестроить его заново
+template <typename T>
+class BloomFilter
+{
+public:
+
+  //Фильтр можно построить только для типов, для которых определён std::hash
+  static constexpr bool isSupported = std::is_default_constructible<std::hash<T>>::value;
+
+  BloomFilter();
+
+  void configure(size_t capacity, double falsePositiveRate, size_t memoryBudget);
+  void add(const T & data);
+  void markRemoved();
+  void clear();
+
+  bool mightContain(const T & data) const;
+  bool isOverCapacity() const;
+  bool isStale() const;
+
+  size_t getCapacity() const;
+  size_t getMemoryUsage() const;
+  double getFalsePositiveRate() const;
+  size_t getMemoryBudget() const;
+
+private:
+
+  //Минимальная ёмкость, чтобы маленькие деревья не перестраивали фильтр слишком часто
+  static constexpr size_t minCapacity = 1024;
+  //Максимальное количество хеш-функций
+  static constexpr size_t maxHashCount = 16;
+
+  std::vector<uint64_t> bits;
+  size_t bitCount;
+  size_t hashCount;
+
+  size_t capacity;
+  double falsePositiveRate;
+  size_t memoryBudget;
+
+  size_t addedCount;
+  size_t removedCount;
+
+  static uint64_t mix(uint64_t hash);
+  static uint64_t hashValue(const T & data);
+};
+
+//Конструктор без параметров, создаёт пустой ненастроенный фильтр
+template <typename T>
+BloomFilter<T>::BloomFilter()
+{
+  bitCount = 0;
+  hashCount = 0;
+  capacity = 0;
+  falsePositiveRate = 0.01;
+  memoryBudget = 0;
+  addedCount = 0;
+  removedCount = 0;
+}
+
+//Настройка фильтра под заданное количество элементов и вероятность ложного срабатывания
+//memoryBudget - ограничение памяти в байтах (0 - без ограничения)
+//Все ранее добавленные элементы сбрасываются
+template <typename T>
+void BloomFilter<T>::configure(size_t capacity, double falsePositiveRate, size_t memoryBudget)
+{
+  if (falsePositiveRate <= 0.0 || falsePositiveRate >= 1.0)
+  {
+    throw std::invalid_argument("Error: False positive rate must be between 0 and 1.\n");
+  }
+
+  this->capacity = std::max(capacity, minCapacity);
+  this->falsePositiveRate = falsePositiveRate;
+  this->memoryBudget = memoryBudget;
+
+  //Оптимальное количество бит: m = -n * ln(p) / ln(2)^2
+  const double ln2 = std::log(2.0);
+  double optimalBits = -static_cast<double>(this->capacity) * std::log(falsePositiveRate) / (ln2 * ln2);
+  bitCount = static_cast<size_t>(std::ceil(optimalBits));
+
+  //Если не хватает памяти, используем столько бит, сколько позволяет бюджет
+  //Вероятность ложного срабатывания при этом будет выше заданной
+  if (memoryBudget != 0)
+  {
+    bitCount = std::min(bitCount, memoryBudget * 8);
+  }
+  bitCount = std::max(bitCount, static_cast<size_t>(64));
+
+  //Оптимальное количество хеш-функций: k = m / n * ln(2)
+  double optimalHashCount = static_cast<double>(bitCount) / this->capacity * ln2;
+  hashCount = static_cast<size_t>(std::round(optimalHashCount));
+  hashCount = std::min(std::max(hashCount, static_cast<size_t>(1)), maxHashCount);
+
+  bits.assign((bitCount + 63) / 64, 0);
+  addedCount = 0;
+  removedCount = 0;
+}
+
+//Добавление элемента в фильтр
+template <typename T>
+void BloomFilter<T>::add(const T & data)
+{
+  if (bitCount == 0)
+  {
+    return;
+  }
+
+  //Двойное хеширование: i-я хеш-функция равна h1 + i * h2
+  uint64_t firstHash = hashValue(data);
+  uint64_t secondHash = mix(firstHash) | 1;
+
+  for (size_t i = 0; i < hashCount; i++)
+  {
+    size_t bit = static_cast<size_t>((firstHash + i * secondHash) % bitCount);
+    bits[bit / 64] |= uint64_t(1) << (bit % 64);
+  }
+
+  addedCount++;
+}
+
+//Учёт удалённого элемента
+//Его биты остаются в фильтре, поэтому фильтр постепенно устаревает
+template <typename T>
+void BloomFilter<T>::markRemoved()
+{
+  removedCount++;
+}
+
+//Очистка фильтра с сохранением настроек
+template <typename T>
+void BloomFilter<T>::clear()
+{
+  std::fill(bits.begin(), bits.end(), 0);
+  addedCount = 0;
+  removedCount = 0;
+}
+
+//Проверка, может ли элемент находиться в множестве
+//false - элемента точно нет, true - элемент, возможно, есть
+template <typename T>
+bool BloomFilter<T>::mightContain(const T & data) const
+{
+  if (bitCount == 0)
+  {
+    return true;
+  }
+
+  uint64_t firstHash = hashValue(data);
+  uint64_t secondHash = mix(firstHash) | 1;
+
+  for (size_t i = 0; i < hashCount; i++)
+  {
+    size_t bit = static_cast<size_t>((firstHash + i * secondHash) % bitCount);
+    if ((bits[bit / 64] & (uint64_t(1) << (bit % 64))) == 0)
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+//Проверка, добавлено ли в фильтр больше элементов, чем он рассчитан
+template <typename T>
+bool BloomFilter<T>::isOverCapacity() const
+{
+  return addedCount > capacity;
+}
+
+//Проверка, устарел ли фильтр из-за удалений
+//Считаем фильтр устаревшим, когда удалена четверть добавленных элементов
+template <typename T>
+bool BloomFilter<T>::isStale() const
+{
+  return removedCount * 4 > addedCount;
+}
+
+//Получение ёмкости фильтра
+template <typename T>
+size_t BloomFilter<T>::getCapacity() const
+{
+  return capacity;
+}
+
+//Получение объёма памяти, занимаемого битами фильтра, в байтах
+template <typename T>
+size_t BloomFilter<T>::getMemoryUsage() const
+{
+  return bits.size() * sizeof(uint64_t);
+}
+
+//Получение заданной вероятности ложного срабатывания
+template <typename T>
+double BloomFilter<T>::getFalsePositiveRate() const
+{
+  return falsePositiveRate;
+}
+
+//Получение ограничения памяти
+template <typename T>
+size_t BloomFilter<T>::getMemoryBudget() const
+{
+  return memoryBudget;
+}
+
+//Перемешивание битов хеша (финализатор splitmix64)
+//std::hash для целых чисел часто возвращает само число, что плохо для фильтра
+template <typename T>
+uint64_t BloomFilter<T>::mix(uint64_t hash)
+{
+  hash ^= hash >> 30;
+  hash *= 0xbf58476d1ce4e5b9ULL;
+  hash ^= hash >> 27;
+  hash *= 0x94d049bb133111ebULL;
+  hash ^= hash >> 31;
+
+  return hash;
+}
+
+//Получение хеша значения
+//Для типов без std::hash фильтр никогда не настраивается, и до вызова дело не доходит
+template <typename T>
+uint64_t BloomFilter<T>::hashValue(const T & data)
+{
+  if constexpr (isSupported)
+  {
+    return mix(std::hash<T>()(data));
+  }
+  else
+  {
+    return 0;
+  }
+}
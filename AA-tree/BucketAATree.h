@@ -0,0 +1,921 @@
+﻿#pragma once
+
+#include <functional>
+#include <stdexcept>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+//Вариант АА-дерева, в котором каждый узел хранит не одно значение, а упорядоченный блок
+//до K значений. Балансировка АА-дерева выполняется над блоками: все значения левого
+//поддерева меньше первого значения блока, все значения правого - больше последнего.
+//Узлов и указателей становится примерно в K раз меньше, а соседние значения лежат
+//в одной кэш-линии, что особенно выгодно для небольших ключей
+template <typename T, size_t K = 16>
+class BucketAATree
+{
+  static_assert(K >= 2, "Bucket must hold at least two elements.");
+
+public:
+
+  class Iterator;
+  class Comparator;
+
+  BucketAATree();
+  BucketAATree(std::initializer_list<T> list);
+  BucketAATree(const BucketAATree & otherTree);
+
+  ~BucketAATree();
+
+  BucketAATree & operator=(BucketAATree otherTree);
+
+  void insert(const T & data);
+  void remove(const T & data);
+  void clear();
+
+  void swap(BucketAATree & firstTree, BucketAATree & secondTree);
+
+  bool contains(const T & data);
+  bool isEmpty();
+  size_t getSize();
+
+  Iterator begin();
+  Iterator end();
+
+private:
+
+  struct Node
+  {
+    T items[K];
+    size_t count;
+    int level;
+    Node * left;
+    Node * right;
+
+    Node()
+    {
+      count = 0;
+      level = 1;
+      left = nullptr;
+      right = nullptr;
+    }
+  };
+
+  //Блок, в котором осталось меньше значений, пополняется от соседнего или сливается с ним
+  static constexpr size_t minBucketSize = K / 2;
+
+  Node * root;
+  Comparator compare;
+
+  Node * insert(Node * node, const T & data);
+  Node * insertLeftmost(Node * node, Node * newNode);
+  Node * skew(Node * node);
+  Node * split(Node * node);
+  Node * removeEmpty(Node * node, const std::vector<bool> & path, size_t depth);
+  Node * removeMin(Node * node, Node * & minNode);
+  Node * removeMax(Node * node, Node * & maxNode);
+  Node * rebalance(Node * node);
+  size_t lowerBound(const Node * node, const T & data);
+  bool isLeaf(Node * node);
+  void deleteSubtree(Node * node);
+  Node * copySubtree(Node * node);
+  size_t getSize(Node * node);
+  static int getLevel(Node * node);
+};
+
+//Класс итератор для перемещения по значениям дерева в порядке от меньшего к большему
+//Хранит узел и позицию значения в блоке узла
+template <typename T, size_t K>
+class BucketAATree<T, K>::Iterator
+{
+public:
+  friend class BucketAATree<T, K>;
+
+  Iterator();
+
+  ~Iterator() = default;
+
+  Iterator & operator=(const Iterator &) = default;
+  Iterator & operator++();
+  Iterator operator++(int);
+  Iterator & operator--();
+  Iterator operator--(int);
+
+  T & operator*();
+  const T & operator*() const;
+  T * operator->();
+  const T * operator->() const;
+
+  bool operator==(const Iterator & otherIterator);
+  bool operator!=(const Iterator & otherIterator);
+
+private:
+  Node * node;
+  size_t index;
+  Node * treeRoot;
+
+  Iterator(Node * node, size_t index, Node * treeRoot);
+  Node * getParent(Node * ancestor, Node * child);
+};
+
+//Конструктор итератора без параметров
+template <typename T, size_t K>
+BucketAATree<T, K>::Iterator::Iterator()
+{
+  this->node = nullptr;
+  this->index = 0;
+  this->treeRoot = nullptr;
+}
+
+//Конструктор итератора с параметрами
+template <typename T, size_t K>
+BucketAATree<T, K>::Iterator::Iterator(Node * node, size_t index, Node * treeRoot)
+{
+  this->node = node;
+  this->index = index;
+  this->treeRoot = treeRoot;
+}
+
+//Префиксный инкремент для итератора
+template <typename T, size_t K>
+typename BucketAATree<T, K>::Iterator & BucketAATree<T, K>::Iterator::operator++()
+{
+  if (node == nullptr)
+  {
+    throw std::logic_error("Error: Unable to use increment with iterator.\n");
+  }
+
+  //1 случай: Если в блоке есть следующее значение
+  if (index + 1 < node->count)
+  {
+    index++;
+    return *this;
+  }
+
+  //2 случай: Если есть правое поддерево
+  if (node->right != nullptr)
+  {
+    //Спускаемся к минимальному узлу в правом поддереве
+    node = node->right;
+    while (node->left != nullptr)
+    {
+      node = node->left;
+    }
+  }
+  //3 случай: Если нет правого поддерева
+  else
+  {
+    //Поднимаемся до первого родителя, для которого текущий узел находится в левом поддереве
+    Node * parent = getParent(treeRoot, node);
+    while (parent != nullptr && node == parent->right)
+    {
+      node = parent;
+      parent = getParent(treeRoot, parent);
+    }
+    node = parent;
+  }
+  index = 0;
+
+  return *this;
+}
+
+//Постфиксный инкремент для итератора
+template <typename T, size_t K>
+typename BucketAATree<T, K>::Iterator BucketAATree<T, K>::Iterator::operator++(int)
+{
+  Iterator currIterator = *this;
+  ++(*this);
+
+  return currIterator;
+}
+
+//Префиксный декремент для итератора
+template <typename T, size_t K>
+typename BucketAATree<T, K>::Iterator & BucketAATree<T, K>::Iterator::operator--()
+{
+  //1 случай: Если итератор на end()
+  if (node == nullptr)
+  {
+    //Спускаемся к максимальному узлу
+    node = treeRoot;
+    if (node == nullptr)
+    {
+      throw std::logic_error("Error: Unable to use decrement with iterator.\n");
+    }
+    while (node->right != nullptr)
+    {
+      node = node->right;
+    }
+    index = node->count - 1;
+    return *this;
+  }
+
+  //2 случай: Если в блоке есть предыдущее значение
+  if (index > 0)
+  {
+    index--;
+    return *this;
+  }
+
+  //3 случай: Если есть левое поддерево
+  if (node->left != nullptr)
+  {
+    //Спускаемся к максимальному узлу в левом поддереве
+    node = node->left;
+    while (node->right != nullptr)
+    {
+      node = node->right;
+    }
+  }
+  //4 случай: Если нет левого поддерева
+  else
+  {
+    //Поднимаемся до первого родителя, для которого текущий узел находится в правом поддереве
+    Node * parent = getParent(treeRoot, node);
+    while (parent != nullptr && node == parent->left)
+    {
+      node = parent;
+      parent = getParent(treeRoot, parent);
+    }
+    node = parent;
+  }
+  index = (node != nullptr) ? node->count - 1 : 0;
+
+  return *this;
+}
+
+//Постфиксный декремент для итератора
+template <typename T, size_t K>
+typename BucketAATree<T, K>::Iterator BucketAATree<T, K>::Iterator::operator--(int)
+{
+  Iterator currIterator = *this;
+  --(*this);
+
+  return currIterator;
+}
+
+//Получение ссылки на значение
+template <typename T, size_t K>
+T & BucketAATree<T, K>::Iterator::operator*()
+{
+  if (node == nullptr)
+  {
+    throw std::logic_error("Error: Dereferencing end iterator.");
+  }
+
+  return node->items[index];
+}
+
+//Получение константной ссылки на значение
+template <typename T, size_t K>
+const T & BucketAATree<T, K>::Iterator::operator*() const
+{
+  if (node == nullptr)
+  {
+    throw std::logic_error("Error: Dereferencing end iterator.");
+  }
+
+  return node->items[index];
+}
+
+//Получение указателя на значение
+template <typename T, size_t K>
+T * BucketAATree<T, K>::Iterator::operator->()
+{
+  if (node == nullptr)
+  {
+    throw std::logic_error("Error: Dereferencing end iterator.");
+  }
+  return &(node->items[index]);
+}
+
+//Получение константного указателя на значение
+template <typename T, size_t K>
+const T * BucketAATree<T, K>::Iterator::operator->() const
+{
+  if (node == nullptr)
+  {
+    throw std::logic_error("Error: Dereferencing end iterator.");
+  }
+  return &(node->items[index]);
+}
+
+//Оператор == для итератора
+template <typename T, size_t K>
+bool BucketAATree<T, K>::Iterator::operator==(const Iterator & otherIterator)
+{
+  return node == otherIterator.node && index == otherIterator.index;
+}
+
+//Оператор != для итератора
+template <typename T, size_t K>
+bool BucketAATree<T, K>::Iterator::operator!=(const Iterator & otherIterator)
+{
+  return !(*this == otherIterator);
+}
+
+//Внутренний метод для нахождения родителя для данного узла
+//Узлы сравниваются по первым значениям блоков
+template <typename T, size_t K>
+typename BucketAATree<T, K>::Node * BucketAATree<T, K>::Iterator::getParent(Node * ancestor, Node * child)
+{
+  if (ancestor == nullptr || child == nullptr || ancestor == child)
+  {
+    return nullptr;
+  }
+
+  if (ancestor->left == child || ancestor->right == child)
+  {
+    return ancestor;
+  }
+
+  if (Comparator()(child->items[0], ancestor->items[0]))
+  {
+    return getParent(ancestor->left, child);
+  }
+  else
+  {
+    return getParent(ancestor->right, child);
+  }
+}
+
+//Компаратор значений блока, наследуется от std::less
+template <typename T, size_t K>
+class BucketAATree<T, K>::Comparator : public std::less<T> {};
+
+//Конструктор без параметров
+template <typename T, size_t K>
+BucketAATree<T, K>::BucketAATree()
+{
+  this->root = nullptr;
+}
+
+//Конструктор со списком инициализации
+template <typename T, size_t K>
+BucketAATree<T, K>::BucketAATree(std::initializer_list<T> list)
+{
+  this->root = nullptr;
+
+  for (auto data: list)
+  {
+    insert(data);
+  }
+}
+
+//Конструктор копирования
+template <typename T, size_t K>
+BucketAATree<T, K>::BucketAATree(const BucketAATree & otherTree)
+{
+  this->root = copySubtree(otherTree.root);
+}
+
+//Деструктор
+template <typename T, size_t K>
+BucketAATree<T, K>::~BucketAATree()
+{
+  clear();
+}
+
+//Оператор = для дерева
+template <typename T, size_t K>
+BucketAATree<T, K> & BucketAATree<T, K>::operator=(BucketAATree otherTree)
+{
+  swap(*this, otherTree);
+
+  return *this;
+}
+
+//Пользовательский метод, который вызывает внутренний метод
+template <typename T, size_t K>
+void BucketAATree<T, K>::insert(const T & data)
+{
+  root = insert(root, data);
+}
+
+template <typename T, size_t K>
+typename BucketAATree<T, K>::Node * BucketAATree<T, K>::insert(Node * node, const T & data)
+{
+  //1 случай: Если узел null, то создаём новый узел с блоком из одного значения
+  if (node == nullptr)
+  {
+    node = new Node();
+    node->items[0] = data;
+    node->count = 1;
+    return node;
+  }
+  //2 случай: Если значение меньше блока и есть куда спускаться, идём в левое поддерево
+  else if (compare(data, node->items[0]) && node->left != nullptr)
+  {
+    node->left = insert(node->left, data);
+  }
+  //3 случай: Если значение больше блока и есть куда спускаться, идём в правое поддерево
+  else if (compare(node->items[node->count - 1], data) && node->right != nullptr)
+  {
+    node->right = insert(node->right, data);
+  }
+  //4 случай: Значение попадает в текущий блок
+  else
+  {
+    size_t position = lowerBound(node, data);
+    if (position < node->count && !compare(data, node->items[position]))
+    {
+      throw std::logic_error("Error: Element already exists.\n");
+    }
+
+    Node * target = node;
+    //Если блок заполнен, переносим его верхнюю половину в новый узел
+    if (node->count == K)
+    {
+      Node * newNode = new Node();
+      size_t half = K / 2;
+      std::move(node->items + half, node->items + K, newNode->items);
+      newNode->count = K - half;
+      node->count = half;
+
+      if (position > half)
+      {
+        target = newNode;
+        position -= half;
+      }
+
+      //Значения нового узла больше текущего блока и меньше правого поддерева,
+      //поэтому новый узел становится самым левым узлом правого поддерева
+      node->right = insertLeftmost(node->right, newNode);
+    }
+
+    //Сдвигаем значения и вставляем новое на своё место
+    std::move_backward(target->items + position, target->items + target->count, target->items + target->count + 1);
+    target->items[position] = data;
+    target->count++;
+  }
+
+  //Балансируем дерево
+  node = skew(node);
+  node = split(node);
+
+  return node;
+}
+
+//Вставка готового узла как самого левого в поддереве
+template <typename T, size_t K>
+typename BucketAATree<T, K>::Node * BucketAATree<T, K>::insertLeftmost(Node * node, Node * newNode)
+{
+  if (node == nullptr)
+  {
+    return newNode;
+  }
+
+  node->left = insertLeftmost(node->left, newNode);
+
+  //Балансируем дерево
+  node = skew(node);
+  node = split(node);
+
+  return node;
+}
+
+//Устраняем левое горизонтальное ребро, совершая правый поворот
+template <typename T, size_t K>
+typename BucketAATree<T, K>::Node * BucketAATree<T, K>::skew(Node * node)
+{
+  if (node != nullptr && node->left != nullptr)
+    //Проверяем, одного ли уровня текущий узел и его левый сын
+    if (node->left->level == node->level)
+    {
+      Node * leftChild = node->left;
+      node->left = leftChild->right;
+      leftChild->right = node;
+      node = leftChild;
+    }
+
+  return node;
+}
+
+//Устраняем два последовательных правых горизонтальных ребра, совершая левый поворот
+template <typename T, size_t K>
+typename BucketAATree<T, K>::Node * BucketAATree<T, K>::split(Node * node)
+{
+  if (node != nullptr && node->right != nullptr && node->right->right != nullptr)
+    //Проверяем, одного ли уровня текущий узел и его правый внук
+    if (node->level == node->right->right->level)
+    {
+      Node * rightChild = node->right;
+      node->right = rightChild->left;
+      rightChild->left = node;
+      rightChild->level += 1;
+      node = rightChild;
+    }
+
+  return node;
+}
+
+//Поиск позиции первого значения блока, которое не меньше заданного
+//Для арифметических типов считаем количество меньших значений без ветвлений:
+//такой цикл компилятор векторизует, и на небольших блоках он быстрее двоичного поиска
+template <typename T, size_t K>
+size_t BucketAATree<T, K>::lowerBound(const Node * node, const T & data)
+{
+  if constexpr (std::is_arithmetic<T>::value)
+  {
+    size_t position = 0;
+    for (size_t i = 0; i < node->count; i++)
+    {
+      position += compare(node->items[i], data) ? 1 : 0;
+    }
+    return position;
+  }
+  else
+  {
+    return std::lower_bound(node->items, node->items + node->count, data, compare) - node->items;
+  }
+}
+
+//Проверка, есть ли заданное значение в дереве
+template <typename T, size_t K>
+bool BucketAATree<T, K>::contains(const T & data)
+{
+  Node * currNode = root;
+
+  //Спускаемся по дереву, пока значение не попадёт в диапазон блока
+  while (currNode != nullptr)
+  {
+    if (compare(data, currNode->items[0]))
+    {
+      currNode = currNode->left;
+    }
+    else if (compare(currNode->items[currNode->count - 1], data))
+    {
+      currNode = currNode->right;
+    }
+    else
+    {
+      //Ищем значение внутри блока
+      size_t position = lowerBound(currNode, data);
+      return !compare(data, currNode->items[position]);
+    }
+  }
+
+  return false;
+}
+
+//Удаление заданного значения
+//Блок, в котором осталось меньше K / 2 значений, забирает значения у соседнего
+//по порядку блока или сливается с ним, поэтому блоки остаются заполненными хотя бы наполовину
+template <typename T, size_t K>
+void BucketAATree<T, K>::remove(const T & data)
+{
+  //Ищем блок со значением, запоминая путь от корня (true - вправо, false - влево)
+  std::vector<bool> path;
+  //Ближайшие предки, для которых блок находится в левом и в правом поддереве:
+  //это соседние блоки, если у блока нет соответствующего поддерева
+  Node * successorAncestor = nullptr;
+  Node * predecessorAncestor = nullptr;
+
+  Node * node = root;
+  while (node != nullptr)
+  {
+    if (compare(data, node->items[0]))
+    {
+      successorAncestor = node;
+      path.push_back(false);
+      node = node->left;
+    }
+    else if (compare(node->items[node->count - 1], data))
+    {
+      predecessorAncestor = node;
+      path.push_back(true);
+      node = node->right;
+    }
+    else
+    {
+      break;
+    }
+  }
+
+  if (node == nullptr)
+  {
+    return;
+  }
+
+  size_t position = lowerBound(node, data);
+  //Если значения нет в блоке, то нет и в дереве
+  if (compare(data, node->items[position]))
+  {
+    return;
+  }
+
+  //Удаляем значение из блока
+  std::move(node->items + position + 1, node->items + node->count, node->items + position);
+  node->count--;
+
+  if (node->count >= minBucketSize)
+  {
+    return;
+  }
+
+  //Ищем соседний блок: сначала следующий по порядку, иначе предыдущий
+  Node * neighbour = nullptr;
+  bool isNeighbourAfter = true;
+  if (node->right != nullptr)
+  {
+    neighbour = node->right;
+    while (neighbour->left != nullptr)
+    {
+      neighbour = neighbour->left;
+    }
+  }
+  else if (successorAncestor != nullptr)
+  {
+    neighbour = successorAncestor;
+  }
+  else if (node->left != nullptr)
+  {
+    neighbour = node->left;
+    while (neighbour->right != nullptr)
+    {
+      neighbour = neighbour->right;
+    }
+    isNeighbourAfter = false;
+  }
+  else if (predecessorAncestor != nullptr)
+  {
+    neighbour = predecessorAncestor;
+    isNeighbourAfter = false;
+  }
+
+  //1 случай: Соседа нет, блок единственный в дереве
+  if (neighbour == nullptr)
+  {
+    if (node->count == 0)
+    {
+      delete root;
+      root = nullptr;
+    }
+    return;
+  }
+
+  //2 случай: Оба блока помещаются в один, переносим значения к соседу и удаляем узел
+  if (node->count + neighbour->count <= K)
+  {
+    if (isNeighbourAfter)
+    {
+      std::move_backward(neighbour->items, neighbour->items + neighbour->count, neighbour->items + neighbour->count + node->count);
+      std::move(node->items, node->items + node->count, neighbour->items);
+    }
+    else
+    {
+      std::move(node->items, node->items + node->count, neighbour->items + neighbour->count);
+    }
+    neighbour->count += node->count;
+    node->count = 0;
+
+    root = removeEmpty(root, path, 0);
+  }
+  //3 случай: Забираем у соседа крайние значения, чтобы блоки сравнялись
+  else
+  {
+    size_t moveCount = (node->count + neighbour->count) / 2 - node->count;
+    if (isNeighbourAfter)
+    {
+      std::move(neighbour->items, neighbour->items + moveCount, node->items + node->count);
+      std::move(neighbour->items + moveCount, neighbour->items + neighbour->count, neighbour->items);
+    }
+    else
+    {
+      std::move_backward(node->items, node->items + node->count, node->items + node->count + moveCount);
+      std::move(neighbour->items + neighbour->count - moveCount, neighbour->items + neighbour->count, node->items);
+    }
+    node->count += moveCount;
+    neighbour->count -= moveCount;
+  }
+
+}
+
+//Удаление пустого узла, до которого ведёт путь path, с восстановлением баланса
+template <typename T, size_t K>
+typename BucketAATree<T, K>::Node * BucketAATree<T, K>::removeEmpty(Node * node, const std::vector<bool> & path, size_t depth)
+{
+  if (depth < path.size())
+  {
+    if (path[depth])
+    {
+      node->right = removeEmpty(node->right, path, depth + 1);
+    }
+    else
+    {
+      node->left = removeEmpty(node->left, path, depth + 1);
+    }
+
+    return rebalance(node);
+  }
+
+  //1 случай: Если узел является листом
+  if (isLeaf(node))
+  {
+    //Удаляем узел
+    delete node;
+    return nullptr;
+  }
+  //2 случай: Если у узла нет левого поддерева
+  else if (node->left == nullptr)
+  {
+    //Забираем блок преемника - минимального узла в правом поддереве
+    Node * successor = nullptr;
+    node->right = removeMin(node->right, successor);
+    std::move(successor->items, successor->items + successor->count, node->items);
+    node->count = successor->count;
+    delete successor;
+  }
+  //3 случай: Если у узла есть левое поддерево
+  else
+  {
+    //Забираем блок предшественника - максимального узла в левом поддереве
+    Node * predecessor = nullptr;
+    node->left = removeMax(node->left, predecessor);
+    std::move(predecessor->items, predecessor->items + predecessor->count, node->items);
+    node->count = predecessor->count;
+    delete predecessor;
+  }
+
+  return rebalance(node);
+}
+
+//Отсоединение минимального узла поддерева
+//У минимального узла нет левого сына, поэтому на его место встаёт правый
+template <typename T, size_t K>
+typename BucketAATree<T, K>::Node * BucketAATree<T, K>::removeMin(Node * node, Node * & minNode)
+{
+  if (node->left == nullptr)
+  {
+    minNode = node;
+    return node->right;
+  }
+
+  node->left = removeMin(node->left, minNode);
+
+  return rebalance(node);
+}
+
+//Отсоединение максимального узла поддерева
+//Максимальный узел всегда лист уровня 1
+template <typename T, size_t K>
+typename BucketAATree<T, K>::Node * BucketAATree<T, K>::removeMax(Node * node, Node * & maxNode)
+{
+  if (node->right == nullptr)
+  {
+    maxNode = node;
+    return node->left;
+  }
+
+  node->right = removeMax(node->right, maxNode);
+
+  return rebalance(node);
+}
+
+//Восстановление баланса после удаления узла из поддерева
+template <typename T, size_t K>
+typename BucketAATree<T, K>::Node * BucketAATree<T, K>::rebalance(Node * node)
+{
+  //Исправляем уровень узла: он должен быть на единицу больше наименьшего уровня сыновей
+  int correctLevel = std::min(getLevel(node->left), getLevel(node->right)) + 1;
+  if (correctLevel < node->level)
+  {
+    node->level = correctLevel;
+    if (node->right != nullptr && correctLevel < node->right->level)
+    {
+      node->right->level = correctLevel;
+    }
+  }
+
+  //Балансируем дерево
+  node = skew(node);
+  if (node->right != nullptr)
+  {
+    node->right = skew(node->right);
+    if (node->right->right != nullptr)
+    {
+      node->right->right = skew(node->right->right);
+    }
+  }
+  node = split(node);
+  if (node->right != nullptr)
+  {
+    node->right = split(node->right);
+  }
+
+  return node;
+}
+
+//Получение уровня узла (у пустого поддерева уровень 0)
+template <typename T, size_t K>
+int BucketAATree<T, K>::getLevel(Node * node)
+{
+  return (node != nullptr) ? node->level : 0;
+}
+
+//Проверка, является ли узел листом дерева
+template <typename T, size_t K>
+bool BucketAATree<T, K>::isLeaf(Node * node)
+{
+  return node != nullptr && node->right == nullptr && node->left == nullptr;
+}
+
+//Удаление целого дерева
+template <typename T, size_t K>
+void BucketAATree<T, K>::clear()
+{
+  deleteSubtree(root);
+  root = nullptr;
+}
+
+//Удаление поддерева
+template <typename T, size_t K>
+void BucketAATree<T, K>::deleteSubtree(Node * node)
+{
+  if (node != nullptr)
+  {
+    deleteSubtree(node->left);
+    deleteSubtree(node->right);
+
+    delete node;
+  }
+}
+
+//Копирование поддерева вместе с блоками и уровнями
+template <typename T, size_t K>
+typename BucketAATree<T, K>::Node * BucketAATree<T, K>::copySubtree(Node * node)
+{
+  if (node == nullptr)
+  {
+    return nullptr;
+  }
+
+  Node * newNode = new Node();
+  std::copy(node->items, node->items + node->count, newNode->items);
+  newNode->count = node->count;
+  newNode->level = node->level;
+  newNode->left = copySubtree(node->left);
+  newNode->right = copySubtree(node->right);
+
+  return newNode;
+}
+
+//Обмен данных деревьев
+template <typename T, size_t K>
+void BucketAATree<T, K>::swap(BucketAATree & firstTree, BucketAATree & secondTree)
+{
+  std::swap(firstTree.root, secondTree.root);
+}
+
+//Проверка, является ли дерево пустым
+template <typename T, size_t K>
+bool BucketAATree<T, K>::isEmpty()
+{
+  return root == nullptr;
+}
+
+//Получение размера дерева (т.е. количества значений)
+template <typename T, size_t K>
+size_t BucketAATree<T, K>::getSize()
+{
+  return getSize(root);
+}
+
+//Внутренний рекурсивный метод для нахождения количества значений
+template <typename T, size_t K>
+size_t BucketAATree<T, K>::getSize(Node * node)
+{
+  size_t size = 0;
+
+  if (node != nullptr)
+  {
+    size = getSize(node->left) + getSize(node->right) + node->count;
+  }
+
+  return size;
+}
+
+//Получение итератора, указывающего на наименьшее значение в дереве
+template <typename T, size_t K>
+typename BucketAATree<T, K>::Iterator BucketAATree<T, K>::begin()
+{
+  if (isEmpty())
+  {
+    return end();
+  }
+
+  Node * minNode = root;
+  while (minNode->left != nullptr)
+  {
+    minNode = minNode->left;
+  }
+
+  return Iterator(minNode, 0, root);
+}
+
+//Получение итератора, указывающего на позицию после последнего значения
+template <typename T, size_t K>
+typename BucketAATree<T, K>::Iterator BucketAATree<T, K>::end()
+{
+  return Iterator(nullptr, 0, root);
+}
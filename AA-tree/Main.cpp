@@ -1,5 +1,8 @@
 ﻿#include <iostream>
+#include <vector>
+#include <atomic>
 #include "AATree.h"
+#include "BucketAATree.h"
 
 int main() {
   try {
@@ -93,6 +96,96 @@ int main() {
       std::cout << "Exception: " << e.what() << "\n";
     }
 
+    //Дерево на блоках: вставка, удаление и обход
+    std::cout << "\nBucketed tree\n";
+    BucketAATree<int, 4> bucketTree;
+    for (int i = 1; i <= 20; i++) {
+      bucketTree.insert(i);
+    }
+    for (int i = 2; i <= 20; i += 2) {
+      bucketTree.remove(i);
+    }
+    std::cout << "Size: " << bucketTree.getSize() << " (expected: 10)\n";
+    std::cout << "Contains 7: " << (bucketTree.contains(7) ? "true" : "false") << " (expected: true)\n";
+    std::cout << "Contains 8: " << (bucketTree.contains(8) ? "true" : "false") << " (expected: false)\n";
+    std::cout << "Elements: ";
+    for (auto bucketIt = bucketTree.begin(); bucketIt != bucketTree.end(); ++bucketIt) {
+      std::cout << *bucketIt << " ";
+    }
+    std::cout << "(expected: 1 3 5 7 9 11 13 15 17 19)\n";
+    std::cout << "Elements in reverse: ";
+    auto bucketIt = bucketTree.end();
+    do {
+      --bucketIt;
+      std::cout << *bucketIt << " ";
+    } while (bucketIt != bucketTree.begin());
+    std::cout << "(expected: 19 17 15 13 11 9 7 5 3 1)\n";
+
+    //Разбиение дерева на части и параллельный обход
+    std::cout << "\nPartition and parallel traversal\n";
+    AATree<int> bigTree;
+    for (int i = 1; i <= 100; i++) {
+      bigTree.insert(i);
+    }
+    std::vector<AATree<int>::Chunk> chunks = bigTree.partition(4);
+    std::cout << "Chunk count: " << chunks.size() << " (expected: 4)\n";
+    std::vector<int> chunkValues;
+    for (auto & chunk : chunks) {
+      chunk.forEach([&](int & value) { chunkValues.push_back(value); });
+    }
+    bool isInOrder = (chunkValues.size() == 100);
+    for (size_t i = 0; isInOrder && i < chunkValues.size(); i++) {
+      isInOrder = (chunkValues[i] == static_cast<int>(i) + 1);
+    }
+    std::cout << "Chunks cover all elements in order: " << (isInOrder ? "true" : "false") << " (expected: true)\n";
+    std::atomic<int> sum(0);
+    bigTree.parallelForEach([&](int & value) { sum += value; }, 4);
+    std::cout << "Sum from parallelForEach: " << sum << " (expected: 5050)\n";
+
+    //Разница между деревьями, её кодирование и применение
+    std::cout << "\nDelta between trees\n";
+    AATree<int> oldTree;
+    AATree<int> newTree;
+    AATree<int> replica;
+    for (int i = 1; i <= 10; i++) {
+      oldTree.insert(i);
+      replica.insert(i);
+      if (i != 3 && i != 4) {
+        newTree.insert(i);
+      }
+    }
+    newTree.insert(11);
+    newTree.insert(12);
+    AATree<int>::Delta delta = AATree<int>::diff(oldTree, newTree);
+    std::cout << "Removed: ";
+    for (int value : delta.removed) {
+      std::cout << value << " ";
+    }
+    std::cout << "(expected: 3 4)\n";
+    std::cout << "Added: ";
+    for (int value : delta.added) {
+      std::cout << value << " ";
+    }
+    std::cout << "(expected: 11 12)\n";
+    std::vector<uint8_t> bytes = AATree<int>::encodeDelta(delta);
+    AATree<int>::Delta decoded = AATree<int>::decodeDelta(bytes);
+    bool isSameDelta = (decoded.added == delta.added && decoded.removed == delta.removed);
+    std::cout << "Decoded delta matches: " << (isSameDelta ? "true" : "false") << " (expected: true)\n";
+    replica.applyDelta(decoded);
+    std::cout << "Elements after applyDelta: ";
+    for (auto replicaIt = replica.begin(); replicaIt != replica.end(); ++replicaIt) {
+      std::cout << *replicaIt << " ";
+    }
+    std::cout << "(expected: 1 2 5 6 7 8 9 10 11 12)\n";
+    AATree<int>::Delta rest = AATree<int>::diff(replica, newTree);
+    std::cout << "Replica equals new tree: " << (rest.added.empty() && rest.removed.empty() ? "true" : "false") << " (expected: true)\n";
+    try {
+      replica.applyDelta(decoded);
+    }
+    catch (const std::logic_error &) {
+      std::cout << "Applying the delta twice throws, size: " << replica.getSize() << " (expected: 10)\n";
+    }
+
   }
   catch (const std::exception & e) {
     std::cerr << "Error: " << e.what() << std::endl;